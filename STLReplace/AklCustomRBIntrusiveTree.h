@@ -0,0 +1,263 @@
+/// Copyright  2019-2024 Lincoln Global Inc. All Rights Reserved.
+///  \file AklCustomRBIntrusiveTree.h
+///  Declaration of the AklCustomRBIntrusiveTree class
+///  \author Ruell Magpayo
+#pragma once
+
+#include "AklCustomRBTreeCommon.h"
+#include "AklCustomRBTreeAlgorithm.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/// Links embedded in a user object so it can be stored in an AklCustomRBIntrusiveTree.
+/// An object can sit in several trees at once through several hooks.
+/// Copying an object does not copy its links.
+struct AklCustomRBTreeHook
+{
+    AklCustomRBTreeColor color;
+    AklCustomRBTreeHook* parent;
+    AklCustomRBTreeHook* left;
+    AklCustomRBTreeHook* right;
+
+    AklCustomRBTreeHook() : color(BLACK), parent(nullptr), left(nullptr), right(nullptr) {}
+    AklCustomRBTreeHook(const AklCustomRBTreeHook&) : color(BLACK), parent(nullptr), left(nullptr), right(nullptr) {}
+    AklCustomRBTreeHook& operator=(const AklCustomRBTreeHook&) { return *this; }
+};
+
+/// Key extractor policy reading the key from a data member of the object
+template <typename T, typename KeyType, KeyType T::*KeyMember>
+struct AklCustomRBTreeMemberKey
+{
+    typedef KeyType Key;
+
+    static const Key& GetKey(const T& object)
+    {
+        return object.*KeyMember;
+    }
+};
+
+/// Red Black Tree over objects that embed an AklCustomRBTreeHook.
+/// The tree never allocates, it only links the hooks of the objects given to it,
+/// and the objects must outlive their membership in the tree.
+/// \tparam T The object type
+/// \tparam HookMember The hook of T used by this tree
+/// \tparam KeyOf Policy with a Key typedef and a static GetKey(const T&)
+template <typename T, AklCustomRBTreeHook T::*HookMember, typename KeyOf>
+class AklCustomRBIntrusiveTree
+{
+public:
+    typedef typename KeyOf::Key Key;
+
+    AklCustomRBIntrusiveTree() : m_root(nullptr), m_size(0)
+    {}
+
+    /// Move constructor, takes the objects of the other tree in O(1)
+    AklCustomRBIntrusiveTree(AklCustomRBIntrusiveTree&& other) : m_root(other.m_root), m_size(other.m_size)
+    {
+        other.m_root = nullptr;
+        other.m_size = 0;
+    }
+
+    ~AklCustomRBIntrusiveTree()
+    {
+        Clear();
+    }
+
+    /// Move Assignment Operator, takes the objects of the other tree in O(1)
+    AklCustomRBIntrusiveTree& operator=(AklCustomRBIntrusiveTree&& other)
+    {
+        if (this != &other)
+        {
+            Clear();
+            std::swap(m_root, other.m_root);
+            std::swap(m_size, other.m_size);
+        }
+        return *this;
+    }
+
+    /// Exchanges the contents of two trees in O(1)
+    void Swap(AklCustomRBIntrusiveTree& other)
+    {
+        std::swap(m_root, other.m_root);
+        std::swap(m_size, other.m_size);
+    }
+
+    /// Links the object into the tree, equal keys are linked to the right
+    /// \param object The object to link, must not be in this tree already
+    void Insert(T& object)
+    {
+        const Key& key = KeyOf::GetKey(object);
+        AklCustomRBTreeHook* y = nullptr;
+        AklCustomRBTreeHook* x = m_root;
+        bool goLeft = false;
+
+        while (x != nullptr)
+        {
+            y = x;
+            goLeft = key < KeyOf::GetKey(*ToObject(x));
+            x = goLeft ? x->left : x->right;
+        }
+
+        Link(&(object.*HookMember), y, goLeft);
+    }
+
+    /// Links the object only if its key is not yet in the tree, with a single descent
+    /// \param object The object to link
+    /// \return the object holding the key and true if the given object was linked
+    std::pair<T*, bool> InsertUnique(T& object)
+    {
+        const Key& key = KeyOf::GetKey(object);
+        AklCustomRBTreeHook* y = nullptr;
+        AklCustomRBTreeHook* x = m_root;
+        bool goLeft = false;
+
+        while (x != nullptr)
+        {
+            T* current = ToObject(x);
+            if (key == KeyOf::GetKey(*current))
+                return std::make_pair(current, false);
+
+            y = x;
+            goLeft = key < KeyOf::GetKey(*current);
+            x = goLeft ? x->left : x->right;
+        }
+
+        Link(&(object.*HookMember), y, goLeft);
+        return std::make_pair(&object, true);
+    }
+
+    /// Check if an object with the key exists in the tree
+    /// \param key The key to find
+    /// \return the object in the tree or null
+    T* Find(const Key& key) const
+    {
+        AklCustomRBTreeHook* current = m_root;
+        while (current != nullptr)
+        {
+            T* object = ToObject(current);
+            if (key == KeyOf::GetKey(*object))
+                return object;
+            else if (key < KeyOf::GetKey(*object))
+                current = current->left;
+            else
+                current = current->right;
+        }
+        return nullptr;
+    }
+
+    /// Unlinks the object from the tree without searching for it
+    /// \param object The object to unlink, must be in this tree
+    void Erase(T& object)
+    {
+        AklCustomRBTreeHook* hook = &(object.*HookMember);
+        Algorithm::Unlink(m_root, hook);
+        ResetHook(hook);
+        --m_size;
+    }
+
+    /// Unlinks all the objects without recursion
+    void Clear()
+    {
+        AklCustomRBTreeHook* x = m_root;
+        while (x != nullptr)
+        {
+            if (x->left != nullptr)
+            {
+                AklCustomRBTreeHook* left = x->left;
+                x->left = left->right;
+                left->right = x;
+                x = left;
+            }
+            else
+            {
+                AklCustomRBTreeHook* right = x->right;
+                ResetHook(x);
+                x = right;
+            }
+        }
+
+        m_root = nullptr;
+        m_size = 0;
+    }
+
+    /// \return the object with the smallest key or null
+    T* First() const
+    {
+        if (m_root == nullptr)
+            return nullptr;
+        return ToObject(Algorithm::Minimum(m_root));
+    }
+
+    /// \return the object following the given object in key order or null
+    T* Next(T& object) const
+    {
+        AklCustomRBTreeHook* next = Algorithm::Successor(&(object.*HookMember));
+        return next != nullptr ? ToObject(next) : nullptr;
+    }
+
+    /// \return the number of objects in the tree
+    int Size() const
+    {
+        return m_size;
+    }
+
+private:
+    typedef AklCustomRBTreeAlgorithm<AklCustomRBTreeHook> Algorithm;
+
+    AklCustomRBTreeHook* m_root;
+    int m_size;
+
+    AklCustomRBIntrusiveTree(const AklCustomRBIntrusiveTree&) = delete;
+    AklCustomRBIntrusiveTree& operator=(const AklCustomRBIntrusiveTree&) = delete;
+
+    /// \return the object that embeds the hook
+    static T* ToObject(AklCustomRBTreeHook* hook)
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - HookOffset());
+    }
+
+    /// \return the byte offset of the hook inside T, computed once
+    static std::ptrdiff_t HookOffset()
+    {
+        static const std::ptrdiff_t offset = ComputeHookOffset();
+        return offset;
+    }
+
+    /// Measures the offset of the hook on storage suitable for a T, no T is constructed or read
+    static std::ptrdiff_t ComputeHookOffset()
+    {
+        static typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        const T* object = reinterpret_cast<const T*>(&storage);
+        return reinterpret_cast<const char*>(&(object->*HookMember)) - reinterpret_cast<const char*>(object);
+    }
+
+    /// Links a red hook below the given parent and rebalances
+    void Link(AklCustomRBTreeHook* hook, AklCustomRBTreeHook* parent, bool goLeft)
+    {
+        hook->color = RED;
+        hook->parent = parent;
+        hook->left = nullptr;
+        hook->right = nullptr;
+
+        if (parent == nullptr)
+            m_root = hook;
+        else if (goLeft)
+            parent->left = hook;
+        else
+            parent->right = hook;
+
+        ++m_size;
+        Algorithm::InsertFixup(m_root, hook);
+    }
+
+    /// Returns the hook to its unlinked state
+    static void ResetHook(AklCustomRBTreeHook* hook)
+    {
+        hook->color = BLACK;
+        hook->parent = nullptr;
+        hook->left = nullptr;
+        hook->right = nullptr;
+    }
+};
@@ -4,6 +4,8 @@
 ///  \author Ruell Magpayo
 #pragma once
 
+#include <cstdlib>
+#include <new>
 #include <vector>
 template <typename T>
 class AklCustomRBNodeCreator
@@ -13,7 +15,9 @@ public:
 		m_currBlockCount(0),
 		m_nodeSize(0),
 		m_maxNodeCount(0),
-		m_memOffset(0)
+		m_memOffset(0),
+		m_blockRemaining(0),
+		m_reserved(0)
 	{
 
 	}
@@ -27,7 +31,7 @@ public:
 		m_nodeSize			= nodeSize;
 		m_currBlockCount	= 0;
 
-		Expand();
+		Expand(m_nodeSize);
 	}
 
 	void Release()
@@ -39,35 +43,96 @@ public:
 
 		m_workArea.clear();
 		m_workArea.shrink_to_fit();
+		m_freeList.clear();
+		m_freeList.shrink_to_fit();
 
 		m_currBlockCount = 0;
 		m_maxNodeCount = 0;
 		m_memOffset = 0;
+		m_blockRemaining = 0;
+		m_reserved = 0;
 	}
 
+	/// Obtains a node, reusing a recycled one unless a reservation is pending
 	T* Obtain()
 	{
-		if (m_currBlockCount + 1 > m_maxNodeCount)
+		if (m_reserved == 0 && !m_freeList.empty())
 		{
-			Expand();
-			m_memOffset = 0;
+			T* recycled = new(m_freeList.back()) T();
+			m_freeList.pop_back();
+
+			++m_currBlockCount;
+			return recycled;
+		}
+
+		if (m_reserved > 0)
+		{
+			--m_reserved;
+		}
+
+		if (m_blockRemaining == 0)
+		{
+			Expand(m_nodeSize);
 		}
 
 		unsigned char* currentMemory = reinterpret_cast<unsigned char*>(m_workArea[m_workArea.size() - 1]);
 		T* node = new(currentMemory + m_memOffset) T();
 		m_memOffset += sizeof(T);
 
+		--m_blockRemaining;
 		++m_currBlockCount;
 		return node;
 	}
+
+	/// Makes sure the next count nodes are obtained from one contiguous block
+	/// \param count The number of nodes about to be obtained
+	void Reserve(int count)
+	{
+		if (m_blockRemaining < count)
+		{
+			Expand(count > m_nodeSize ? count : m_nodeSize);
+		}
+		m_reserved = count;
+	}
+
+	/// Returns a node that left its tree so that a later Obtain reuses it
+	/// \param node The node obtained from this creator
+	void Recycle(T* node)
+	{
+		node->~T();
+		m_freeList.push_back(node);
+		--m_currBlockCount;
+	}
+
+	/// Returns nodes that left their tree in bulk
+	/// \param nodes The nodes obtained from this creator
+	/// \param count The number of nodes
+	void Recycle(T* const* nodes, int count)
+	{
+		m_freeList.reserve(m_freeList.size() + count);
+		for (int i = 0; i < count; i++)
+		{
+			nodes[i]->~T();
+			m_freeList.push_back(nodes[i]);
+		}
+		m_currBlockCount -= count;
+	}
+
+	/// \return the number of nodes obtained from the creator and not recycled
+	int GetCount() const
+	{
+		return m_currBlockCount;
+	}
 	
 private:
 
-	void Expand()
+	void Expand(int nodeCount)
 	{
-		void* memory = static_cast<T*>(std::malloc(sizeof(T) * m_nodeSize));
+		void* memory = static_cast<T*>(std::malloc(sizeof(T) * nodeCount));
 		m_workArea.push_back(memory);
-		m_maxNodeCount += m_nodeSize;
+		m_maxNodeCount += nodeCount;
+		m_memOffset = 0;
+		m_blockRemaining = nodeCount;
 	}
 
 	int m_currBlockCount;
@@ -75,5 +140,8 @@ private:
 	int m_nodeSize;
 	int m_maxNodeCount;
 	int m_memOffset;
+	int m_blockRemaining;
+	int m_reserved;
+	std::vector<T*> m_freeList;
 };
 
@@ -5,232 +5,159 @@
 #pragma once
 
 #include "AklCustomRBTreeCommon.h"
+#include "AklCustomRBTreeAlgorithm.h"
 #include "AklCustomRBNodeCreator.h"
 
 #include <iostream>
 #include <set>
+#include <utility>
+#include <vector>
 
-template <typename Value>
+/// \tparam Mode The storage of equal values, AklCustomRBTreeCountedMode keeps one node per
+/// distinct value with its multiplicity while the default keeps one node per inserted value
+template <typename Value, typename Mode = AklCustomRBTreeMultiMode<Value>>
 class AklCustomRBTree 
 {
-private:
-    AklCustomRBTreeNode<Value>* m_root;
-    AklCustomRBNodeCreator<AklCustomRBTreeNode<Value>>* m_creator;
+public:
+    typedef typename Mode::Node Node;
 
-    /// Performs a left rotation around the given node.
-    /// This operation maintains the binary search tree property.
-    /// \param x The node around which the left rotation is performed.
-    void LeftRotate(AklCustomRBTreeNode<Value>* x) 
+private:
+    typedef AklCustomRBTreeAlgorithm<Node> Algorithm;
+
+    Node* m_root;
+    AklCustomRBNodeCreator<Node>* m_creator;
+    int m_size;
+    // advanced whenever nodes leave the tree, so cursors taken before know their node may be gone
+    unsigned int m_generation;
+
+    /// Creates a detached red node holding the value.
+    /// \param value The value of the node
+    /// \param creator The creator to obtain the node from, or null to allocate from the heap
+    /// \return the new node
+    static Node* CreateNode(const Value& value, AklCustomRBNodeCreator<Node>* creator)
     {
-        AklCustomRBTreeNode<Value>* y = x->right;
-        x->right = y->left;
-
-        if (y->left != nullptr)
-            y->left->parent = x;
-
-        y->parent = x->parent;
-
-        if (x->parent == nullptr)
-            m_root = y;
-        else if (x == x->parent->left)
-            x->parent->left = y;
+        Node* node = nullptr;
+        if (creator)
+        {
+            node = creator->Obtain();
+            node->value = value;
+            Mode::SetCount(node, 1);
+            node->color = RED;
+            node->parent = nullptr;
+            node->left = nullptr;
+            node->right = nullptr;
+        }
         else
-            x->parent->right = y;
-
-        y->left = x;
-        x->parent = y;
+        {
+            node = new Node(value, RED, nullptr, nullptr, nullptr);
+        }
+        return node;
     }
 
-    /// Performs a right rotation around the given node.
-    /// This operation maintains the binary search tree property.
-    /// \param y The node around which the right rotation is performed.
-    void RightRotate(AklCustomRBTreeNode<Value>* y) 
+    /// \brief Copies the subtree rooted at the given node without recursion.
+    /// Nodes are created in pre-order, so a reserved creator hands them out from one block.
+    /// \param source The root of the subtree to copy
+    /// \param creator The creator to obtain the nodes from, or null to allocate from the heap
+    /// \return the root of the copy, with parents linked
+    static Node* CopyNodes(const Node* source, AklCustomRBNodeCreator<Node>* creator)
     {
-        AklCustomRBTreeNode<Value>* x = y->left;
-        y->left = x->right;
-
-        if (x->right != nullptr)
-            x->right->parent = y;
+        if (source == nullptr)
+            return nullptr;
 
-        x->parent = y->parent;
+        Node* root = CreateNode(source->value, creator);
+        root->color = source->color;
+        Mode::SetCount(root, Mode::GetCount(source));
 
-        if (y->parent == nullptr)
-            m_root = x;
-        else if (y == y->parent->left)
-            y->parent->left = x;
-        else
-            y->parent->right = x;
+        Node* destination = root;
+        const Node* sourceRoot = source;
+        while (true)
+        {
+            if (source->left != nullptr && destination->left == nullptr)
+            {
+                source = source->left;
+                destination->left = CreateNode(source->value, creator);
+                destination->left->parent = destination;
+                destination = destination->left;
+                destination->color = source->color;
+                Mode::SetCount(destination, Mode::GetCount(source));
+            }
+            else if (source->right != nullptr && destination->right == nullptr)
+            {
+                source = source->right;
+                destination->right = CreateNode(source->value, creator);
+                destination->right->parent = destination;
+                destination = destination->right;
+                destination->color = source->color;
+                Mode::SetCount(destination, Mode::GetCount(source));
+            }
+            else if (source == sourceRoot)
+            {
+                break;
+            }
+            else
+            {
+                source = source->parent;
+                destination = destination->parent;
+            }
+        }
 
-        x->right = y;
-        y->parent = x;
+        return root;
     }
 
-    /// Restores the Red-Black Tree properties after an insertion.
-    /// Fixes any violations caused by the insertion.
-    /// \param z The node that was inserted and may have caused violations.
-    void InsertFixup(AklCustomRBTreeNode<Value>* z) 
+    /// \brief Deletes the heap allocated subtree rooted at the given node without recursion.
+    /// Left children are rotated up until the node has none, then the node is deleted.
+    /// \param x The root of the subtree to delete
+    void ClearInternal(Node* x)
     {
-        while (z->parent != nullptr && z->parent->color == RED) 
+        while (x != nullptr)
         {
-            if (z->parent == z->parent->parent->left) {
-                AklCustomRBTreeNode<Value>* y = z->parent->parent->right;
-                if (y != nullptr && y->color == RED) 
-                {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
-                }
-                else 
-                {
-                    if (z == z->parent->right) 
-                    {
-                        z = z->parent;
-                        LeftRotate(z);
-                    }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    RightRotate(z->parent->parent);
-                }
+            if (x->left != nullptr)
+            {
+                Node* left = x->left;
+                x->left = left->right;
+                left->right = x;
+                x = left;
             }
-            else 
+            else
             {
-                AklCustomRBTreeNode<Value>* y = z->parent->parent->left;
-                if (y != nullptr && y->color == RED) 
-                {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
-                }
-                else 
-                {
-                    if (z == z->parent->left) 
-                    {
-                        z = z->parent;
-                        RightRotate(z);
-                    }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    LeftRotate(z->parent->parent);
-                }
+                Node* right = x->right;
+                delete x;
+                x = right;
             }
         }
-        m_root->color = BLACK;
-    }
-
-    /// \brief Replaces one subtree as a child of its parent with another subtree.
-    /// Used in transplanting subtrees during the deletion operation.
-    /// \param u The node whose subtree is to be replaced.
-    /// \param v The node whose subtree replaces the subtree rooted at u.
-    void Transplant(AklCustomRBTreeNode<Value>* u, AklCustomRBTreeNode<Value>* v) 
-    {
-        if (u->parent == nullptr)
-            m_root = v;
-        else if (u == u->parent->left)
-            u->parent->left = v;
-        else
-            u->parent->right = v;
-
-        if (v != nullptr)
-            v->parent = u->parent;
     }
 
-    /// \brief Finds the node with the minimum key in the subtree rooted at the given node.
-    /// Used in the deletion operation to find the successor of a node.
-    /// \param x The root of the subtree for which the minimum key is to be found.
-    /// \return The node with the minimum key in the subtree rooted at x.
-    AklCustomRBTreeNode<Value>* Minimum(AklCustomRBTreeNode<Value>* x)
+    /// \brief Resolves the creator of a new node.
+    /// An empty tree adopts the given creator so that teardown knows who owns the nodes,
+    /// a non-empty tree keeps its owner.
+    /// \param creator The creator passed to the insertion, or null
+    /// \return the creator of the tree, or null for heap allocated nodes
+    AklCustomRBNodeCreator<Node>* OwnerCreator(AklCustomRBNodeCreator<Node>* creator)
     {
-        while (x->left != nullptr)
-            x = x->left;
-        return x;
+        if (m_root == nullptr && creator != nullptr)
+            m_creator = creator;
+        return m_creator;
     }
 
-
-    /// \brief Restores the Red-Black Tree properties after a deletion.
-    /// Fixes any violations caused by the deletion.
-    /// \param x The node that replaces the deleted node in the tree.
-    void EraseFixup(AklCustomRBTreeNode<Value>* x) 
+    /// \brief Counts the nodes holding the same value as the given node.
+    /// Equal values are inserted to the right, so they sit next to the node in order.
+    /// \param node A node holding the value
+    /// \return the number of nodes holding the value
+    int CountEqual(Node* node)
     {
-        while (x != m_root && (x == nullptr || x->color == BLACK)) 
-        {
-            if (x == x->parent->left) {
-                AklCustomRBTreeNode<Value>* w = x->parent->right;
-                if (w->color == RED) 
-                {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    LeftRotate(x->parent);
-                    w = x->parent->right;
-                }
-                if ((w->left == nullptr || w->left->color == BLACK) &&
-                    (w->right == nullptr || w->right->color == BLACK)) 
-                {
-                    w->color = RED;
-                    x = x->parent;
-                }
-                else 
-                {
-                    if (w->right == nullptr || w->right->color == BLACK) 
-                    {
-                        if (w->left != nullptr)
-                            w->left->color = BLACK;
-                        w->color = RED;
-                        RightRotate(w);
-                        w = x->parent->right;
-                    }
-                    w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    if (w->right != nullptr)
-                        w->right->color = BLACK;
-                    LeftRotate(x->parent);
-                    x = m_root;
-                }
-            }
-            else {
-                AklCustomRBTreeNode<Value>* w = x->parent->left;
-                if (w->color == RED) 
-                {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    RightRotate(x->parent);
-                    w = x->parent->left;
-                }
-                if ((w->right == nullptr || w->right->color == BLACK) &&
-                    (w->left == nullptr || w->left->color == BLACK)) 
-                {
-                    w->color = RED;
-                    x = x->parent;
-                }
-                else 
-                {
-                    if (w->left == nullptr || w->left->color == BLACK) 
-                    {
-                        if (w->right != nullptr)
-                            w->right->color = BLACK;
-                        w->color = RED;
-                        LeftRotate(w);
-                        w = x->parent->left;
-                    }
-                    w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    if (w->left != nullptr)
-                        w->left->color = BLACK;
-                    RightRotate(x->parent);
-                    x = m_root;
-                }
-            }
-        }
-        if (x != nullptr)
-            x->color = BLACK;
+        int count = 1;
+        for (Node* x = Algorithm::Predecessor(node); x != nullptr && x->value == node->value; x = Algorithm::Predecessor(x))
+            ++count;
+        for (Node* x = Algorithm::Successor(node); x != nullptr && x->value == node->value; x = Algorithm::Successor(x))
+            ++count;
+        return count;
     }
 
     /// \brief Performs an in-order traversal of the subtree rooted at the given node.
     /// Appends the values in sorted order to the provided set.
     /// \param x The root of the subtree to be traversed in-order.
     /// \param result The set to which the values are appended in sorted order.
-    void InorderTraversalHelper(AklCustomRBTreeNode<Value>* x, std::set<Value>& result) 
+    void InorderTraversalHelper(Node* x, std::set<Value>& result) 
     {
         if (x != nullptr) 
         {
@@ -241,39 +168,215 @@ private:
     }
 
 public:
-    AklCustomRBTree() : m_root(nullptr), m_creator(nullptr)
+    /// Remembers the last node reached by a lookup so the next nearby lookup starts from it.
+    /// Erase, EraseSorted, EraseIf, Clear, Swap and moving or assigning the tree forget the node,
+    /// and the next lookup starts from the root. A cursor must not outlive its tree.
+    class Cursor
+    {
+    public:
+        Cursor(AklCustomRBTree& tree) : m_tree(&tree), m_node(nullptr), m_generation(tree.m_generation)
+        {}
+
+        /// Finds the value starting from the last node reached
+        /// \param value The value to find
+        /// \return the Node in the tree or null
+        Node* Seek(const Value& value)
+        {
+            return m_tree->FindNear(*this, value);
+        }
+
+        /// \return the last node reached, the node found or the last one visited on a miss,
+        /// null once nodes have left the tree since
+        Node* Get() const
+        {
+            return m_generation == m_tree->m_generation ? m_node : nullptr;
+        }
+
+        /// Forgets the last node, the next lookup starts from the root
+        void Reset()
+        {
+            m_node = nullptr;
+        }
+
+    private:
+        friend class AklCustomRBTree;
+
+        AklCustomRBTree* m_tree;
+        Node* m_node;
+        unsigned int m_generation;
+    };
+
+    AklCustomRBTree() : m_root(nullptr), m_creator(nullptr), m_size(0), m_generation(0)
     {}
 
+    /// Copy constructor, the copy obtains its nodes from the same creator
+    AklCustomRBTree(const AklCustomRBTree& other) : m_root(nullptr), m_creator(other.m_creator), m_size(0), m_generation(0)
+    {
+        if (m_creator)
+            m_creator->Reserve(other.m_size);
+        m_root = CopyNodes(other.m_root, m_creator);
+        m_size = other.m_size;
+    }
+
+    /// Move constructor, takes the nodes of the other tree in O(1)
+    AklCustomRBTree(AklCustomRBTree&& other) : m_root(other.m_root), m_creator(other.m_creator), m_size(other.m_size), m_generation(0)
+    {
+        other.m_root = nullptr;
+        other.m_size = 0;
+        ++other.m_generation;
+    }
+
+    ~AklCustomRBTree()
+    {
+        Clear();
+    }
+
+    /// Assignment Operator, the copy obtains its nodes from this tree's creator
+    AklCustomRBTree& operator=(const AklCustomRBTree& other)
+    {
+        if (this != &other)
+        {
+            Clear();
+            if (m_creator)
+                m_creator->Reserve(other.m_size);
+            m_root = CopyNodes(other.m_root, m_creator);
+            m_size = other.m_size;
+        }
+        return *this;
+    }
+
+    /// Move Assignment Operator, takes the nodes of the other tree in O(1)
+    AklCustomRBTree& operator=(AklCustomRBTree&& other)
+    {
+        if (this != &other)
+        {
+            Clear();
+            m_root = other.m_root;
+            m_creator = other.m_creator;
+            m_size = other.m_size;
+            other.m_root = nullptr;
+            other.m_size = 0;
+            ++other.m_generation;
+        }
+        return *this;
+    }
+
+    /// Exchanges the contents of two trees in O(1)
+    void Swap(AklCustomRBTree& other)
+    {
+        std::swap(m_root, other.m_root);
+        std::swap(m_creator, other.m_creator);
+        std::swap(m_size, other.m_size);
+        ++m_generation;
+        ++other.m_generation;
+    }
+
+    /// Copies the tree in linear time into one block of the target creator
+    /// \param targetCreator The creator of the copy, or null to allocate from the heap
+    /// \return the copy
+    AklCustomRBTree Clone(AklCustomRBNodeCreator<Node>* targetCreator) const
+    {
+        AklCustomRBTree result;
+        result.m_creator = targetCreator;
+        if (targetCreator)
+            targetCreator->Reserve(m_size);
+        result.m_root = CopyNodes(m_root, targetCreator);
+        result.m_size = m_size;
+        return result;
+    }
+
+    /// Clears the tree
+    void Clear()
+    {
+        // if the nodes are created from a creator, we dont need to do the cleanup
+        if (m_creator == nullptr)
+            ClearInternal(m_root);
+
+        m_root = nullptr;
+        m_size = 0;
+        ++m_generation;
+    }
+
+    /// \return the number of nodes in the tree, distinct values in counted mode
+    int Size() const
+    {
+        return m_size;
+    }
+
     /// Sets the node creator
-    void SetNodeCreator(AklCustomRBNodeCreator<AklCustomRBTreeNode<Value>>* creator)
+    /// A tree has one owner for all its nodes, so the creator only changes while the tree is empty
+    void SetNodeCreator(AklCustomRBNodeCreator<Node>* creator)
     {
-        m_creator = creator;
+        if (m_root == nullptr)
+            m_creator = creator;
     }
 
-    /// Insert element to the tree
-    void Insert(Value value, AklCustomRBNodeCreator<AklCustomRBTreeNode<Value>>* creator = nullptr)
+    /// \return the number of occurrences of the value in the tree
+    int Count(Value value)
     {
-        AklCustomRBTreeNode<Value>* z = nullptr;
-        AklCustomRBTreeNode<Value>* y = nullptr;
-        AklCustomRBTreeNode<Value>* x = m_root;
+        Node* node = Find(value);
+        if (node == nullptr)
+            return 0;
+        return Mode::IsCounted ? Mode::GetCount(node) : CountEqual(node);
+    }
 
-        AklCustomRBNodeCreator<AklCustomRBTreeNode<Value>>* nodeCreator = 
-            creator != nullptr ? creator : m_creator;
+    /// Insert the value only if it is not yet in the tree, with a single descent.
+    /// Nothing is allocated when the value already exists.
+    /// \param value The value to insert
+    /// \param creator The creator to use instead of the tree's creator, see Insert
+    /// \return the node holding the value and true if it was inserted
+    std::pair<Node*, bool> InsertUnique(const Value& value, AklCustomRBNodeCreator<Node>* creator = nullptr)
+    {
+        Node* y = nullptr;
+        Node* x = m_root;
+        bool goLeft = false;
 
-        if (nodeCreator)
+        while (x != nullptr)
         {
-            z = m_creator->Obtain();
-            z->value = value;
-            z->color = RED;
-            z->parent = nullptr;
-            z->left = nullptr;
-            z->right = nullptr;
+            if (value == x->value)
+                return std::make_pair(x, false);
+
+            y = x;
+            goLeft = value < x->value;
+            x = goLeft ? x->left : x->right;
         }
+
+        Node* z = CreateNode(value, OwnerCreator(creator));
+
+        z->parent = y;
+        if (y == nullptr)
+            m_root = z;
+        else if (goLeft)
+            y->left = z;
         else
+            y->right = z;
+
+        ++m_size;
+        Algorithm::InsertFixup(m_root, z);
+        return std::make_pair(z, true);
+    }
+
+    /// Insert element to the tree
+    /// In counted mode an existing value only has its count incremented
+    /// \param value The value to insert
+    /// \param creator The creator to use instead of the tree's creator. On an empty tree it
+    /// becomes the tree's creator, on a non-empty tree it is ignored since all the nodes
+    /// of a tree must come from one owner
+    void Insert(Value value, AklCustomRBNodeCreator<Node>* creator = nullptr)
+    {
+        if (Mode::IsCounted)
         {
-            z = new AklCustomRBTreeNode<Value>(value, RED, nullptr, nullptr, nullptr);
+            std::pair<Node*, bool> result = InsertUnique(value, creator);
+            if (!result.second)
+                Mode::SetCount(result.first, Mode::GetCount(result.first) + 1);
+            return;
         }
 
+        Node* y = nullptr;
+        Node* x = m_root;
+
+        Node* z = CreateNode(value, OwnerCreator(creator));
+
         while (x != nullptr) 
         {
             y = x;
@@ -291,15 +394,16 @@ public:
         else
             y->right = z;
 
-        InsertFixup(z);
+        ++m_size;
+        Algorithm::InsertFixup(m_root, z);
     }
 
     /// Check if element exist in the tree
     /// \param value The value to find
     /// \return the Node in the tree or null
-    AklCustomRBTreeNode<Value>* Find(Value value) 
+    Node* Find(Value value) 
     {
-        AklCustomRBTreeNode<Value>* current = m_root;
+        Node* current = m_root;
         while (current != nullptr) {
             if (value == current->value)
                 return current;
@@ -311,51 +415,179 @@ public:
         return nullptr;
     }
 
+    /// \brief Finger search, finds the value starting from the cursor's last node.
+    /// Climbs through the parents only until the subtree must hold the value, then descends,
+    /// so a value d positions away from the previous one costs O(log d).
+    /// \param cursor The cursor of this tree, moved to the node reached. The search starts from
+    /// the root when the node may have left the tree, a cursor of another tree is rebound to this one
+    /// \param value The value to find
+    /// \return the Node in the tree or null
+    Node* FindNear(Cursor& cursor, const Value& value)
+    {
+        if (cursor.m_tree != this || cursor.m_generation != m_generation)
+        {
+            cursor.m_tree = this;
+            cursor.m_node = nullptr;
+            cursor.m_generation = m_generation;
+        }
+
+        Node* x = cursor.m_node != nullptr ? cursor.m_node : m_root;
+        if (x == nullptr)
+            return nullptr;
+
+        if (cursor.m_node != nullptr && !(value == x->value))
+        {
+            if (x->value < value)
+            {
+                // a left child whose parent is above the value bounds the value from both sides
+                while (x->parent != nullptr && !(x == x->parent->left && value < x->parent->value))
+                {
+                    x = x->parent;
+                    if (value == x->value)
+                        break;
+                }
+            }
+            else
+            {
+                while (x->parent != nullptr && !(x == x->parent->right && x->parent->value < value))
+                {
+                    x = x->parent;
+                    if (value == x->value)
+                        break;
+                }
+            }
+        }
+
+        while (true)
+        {
+            if (value == x->value)
+            {
+                cursor.m_node = x;
+                return x;
+            }
+
+            Node* next = value < x->value ? x->left : x->right;
+            if (next == nullptr)
+            {
+                cursor.m_node = x;
+                return nullptr;
+            }
+            x = next;
+        }
+    }
+
+    /// Finds a batch of values, advancing a group of independent searches in lockstep
+    /// and prefetching the next node of each search so that their cache misses overlap.
+    /// \param values The values to find
+    /// \param count The number of values
+    /// \param result Receives the Node in the tree or null for every value
+    void FindBatch(const Value* values, int count, Node** result)
+    {
+        Node* current[AKL_RBTREE_BATCH_GROUP_SIZE];
+
+        for (int base = 0; base < count; base += AKL_RBTREE_BATCH_GROUP_SIZE)
+        {
+            int groupSize = count - base;
+            if (groupSize > AKL_RBTREE_BATCH_GROUP_SIZE)
+                groupSize = AKL_RBTREE_BATCH_GROUP_SIZE;
+
+            for (int i = 0; i < groupSize; i++)
+            {
+                current[i] = m_root;
+                result[base + i] = nullptr;
+            }
+
+            int active = groupSize;
+            while (active > 0)
+            {
+                active = 0;
+                for (int i = 0; i < groupSize; i++)
+                {
+                    Node* node = current[i];
+                    if (node == nullptr)
+                        continue;
+
+                    const Value& value = values[base + i];
+                    if (value == node->value)
+                    {
+                        result[base + i] = node;
+                        current[i] = nullptr;
+                        continue;
+                    }
+
+                    node = value < node->value ? node->left : node->right;
+                    if (node != nullptr)
+                    {
+                        AKL_RBTREE_PREFETCH(node);
+                        ++active;
+                    }
+                    current[i] = node;
+                }
+            }
+        }
+    }
+
     /// Erase the value in the tree
+    /// In counted mode only one occurrence is removed
     /// \param value The value to erase
     void Erase(Value value) 
     {
-        AklCustomRBTreeNode<Value>* z = Find(value);
+        Node* z = Find(value);
         if (z == nullptr)
             return;
 
-        AklCustomRBTreeNode<Value>* y = z;
-        AklCustomRBTreeNode<Value>* x;
-        AklCustomRBTreeColor yOriginalColor = y->color;
-
-        if (z->left == nullptr) 
+        if (Mode::IsCounted && Mode::GetCount(z) > 1)
         {
-            x = z->right;
-            Transplant(z, z->right);
+            Mode::SetCount(z, Mode::GetCount(z) - 1);
+            return;
         }
-        else if (z->right == nullptr) 
+
+        EraseNode(z);
+    }
+
+    /// Erase every node holding one of the sorted values, whatever its count.
+    /// Each value is searched from the node after the previous one, so k values
+    /// d positions apart cost O(k log d), and the search stops once the values run out.
+    /// \param first The first of the values, in ascending order
+    /// \param last The end of the values
+    /// \return the number of nodes erased
+    template <typename Iterator>
+    int EraseSorted(Iterator first, Iterator last)
+    {
+        std::vector<Node*> matches;
+
+        // every node before x is smaller than the current value
+        Node* x = m_root != nullptr ? Algorithm::Minimum(m_root) : nullptr;
+        for (; x != nullptr && first != last; ++first)
         {
-            x = z->left;
-            Transplant(z, z->left);
+            if (x->value < *first)
+                x = LowerBoundNear(x, *first);
+
+            for (; x != nullptr && x->value == *first; x = Algorithm::Successor(x))
+                matches.push_back(x);
         }
-        else 
+
+        EraseNodes(matches);
+        return static_cast<int>(matches.size());
+    }
+
+    /// Erase every node whose value satisfies the predicate, whatever its count, in one traversal
+    /// \param predicate Called with each value, returns true to erase it
+    /// \return the number of nodes erased
+    template <typename Predicate>
+    int EraseIf(Predicate predicate)
+    {
+        std::vector<Node*> matches;
+
+        Node* x = m_root != nullptr ? Algorithm::Minimum(m_root) : nullptr;
+        for (; x != nullptr; x = Algorithm::Successor(x))
         {
-            y = Minimum(z->right);
-            yOriginalColor = y->color;
-            x = y->right;
-            if (y->parent == z)
-                x->parent = y;
-            else 
-            {
-                Transplant(y, y->right);
-                y->right = z->right;
-                y->right->parent = y;
-            }
-            Transplant(z, y);
-            y->left = z->left;
-            y->left->parent = y;
-            y->color = z->color;
+            if (predicate(x->value))
+                matches.push_back(x);
         }
 
-        delete z;
-
-        if (yOriginalColor == BLACK)
-            EraseFixup(x);
+        EraseNodes(matches);
+        return static_cast<int>(matches.size());
     }
 
     /// Return the set version of the list
@@ -366,4 +598,139 @@ public:
         InorderTraversalHelper(m_root, result);
         return result;
     }
+
+private:
+    /// \brief Unlinks the node from the tree and releases it.
+    /// The successor is relinked in place of the node, so pointers to other nodes stay valid.
+    /// \param z The node to erase
+    void EraseNode(Node* z)
+    {
+        Algorithm::Unlink(m_root, z);
+
+        if (m_creator)
+            m_creator->Recycle(z);
+        else
+            delete z;
+        --m_size;
+        ++m_generation;
+    }
+
+    /// \brief Finger search for the first node not smaller than the value.
+    /// Climbs from the node only until the subtree must hold the answer, then descends,
+    /// so an answer d positions away costs O(log d).
+    /// \param x A node smaller than the value
+    /// \param value The value to find
+    /// \return the first node not smaller than the value, or null if there is none
+    static Node* LowerBoundNear(Node* x, const Value& value)
+    {
+        // a left child whose parent is not smaller than the value bounds the answer
+        Node* result = nullptr;
+        while (x->parent != nullptr)
+        {
+            if (x == x->parent->left && !(x->parent->value < value))
+            {
+                result = x->parent;
+                break;
+            }
+            x = x->parent;
+        }
+
+        while (x != nullptr)
+        {
+            if (x->value < value)
+                x = x->right;
+            else
+            {
+                result = x;
+                x = x->left;
+            }
+        }
+        return result;
+    }
+
+    /// \brief Removes the given nodes, which are in order, and releases them in bulk.
+    /// When at least half of the tree goes, the survivors are rebuilt into a balanced
+    /// tree in one in-order pass, otherwise the nodes are unlinked one by one without a search.
+    /// \param nodes The nodes to remove, in order
+    void EraseNodes(std::vector<Node*>& nodes)
+    {
+        if (nodes.empty())
+            return;
+
+        int count = static_cast<int>(nodes.size());
+        if (count * 2 >= m_size)
+        {
+            std::vector<Node*> survivors;
+            survivors.reserve(m_size - count);
+
+            int next = 0;
+            for (Node* x = Algorithm::Minimum(m_root); x != nullptr; x = Algorithm::Successor(x))
+            {
+                if (next < count && x == nodes[next])
+                    ++next;
+                else
+                    survivors.push_back(x);
+            }
+
+            m_root = BuildBalanced(survivors);
+        }
+        else
+        {
+            for (int i = 0; i < count; i++)
+                Algorithm::Unlink(m_root, nodes[i]);
+        }
+
+        if (m_creator)
+        {
+            m_creator->Recycle(nodes.data(), count);
+        }
+        else
+        {
+            for (int i = 0; i < count; i++)
+                delete nodes[i];
+        }
+        m_size -= count;
+        ++m_generation;
+    }
+
+    /// \brief Links the sorted nodes into a balanced Red-Black Tree.
+    /// Every level is black except the last one when it is not full, which is red.
+    /// \param nodes The nodes in order
+    /// \return the root of the tree
+    static Node* BuildBalanced(std::vector<Node*>& nodes)
+    {
+        int count = static_cast<int>(nodes.size());
+
+        int levels = 0;
+        while ((1 << levels) - 1 < count)
+            ++levels;
+        int redDepth = (1 << levels) - 1 == count ? -1 : levels - 1;
+
+        Node* root = BuildBalancedHelper(nodes, 0, count, 0, redDepth);
+        if (root != nullptr)
+            root->parent = nullptr;
+        return root;
+    }
+
+    /// \brief Links nodes[begin, end) into a subtree rooted at the middle node.
+    /// The recursion depth is the height of the resulting tree.
+    static Node* BuildBalancedHelper(std::vector<Node*>& nodes, int begin, int end, int depth, int redDepth)
+    {
+        if (begin >= end)
+            return nullptr;
+
+        int middle = begin + (end - begin) / 2;
+        Node* x = nodes[middle];
+        x->color = depth == redDepth ? RED : BLACK;
+
+        x->left = BuildBalancedHelper(nodes, begin, middle, depth + 1, redDepth);
+        if (x->left != nullptr)
+            x->left->parent = x;
+
+        x->right = BuildBalancedHelper(nodes, middle + 1, end, depth + 1, redDepth);
+        if (x->right != nullptr)
+            x->right->parent = x;
+
+        return x;
+    }
 };
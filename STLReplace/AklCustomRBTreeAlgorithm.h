@@ -0,0 +1,349 @@
+/// Copyright  2019-2024 Lincoln Global Inc. All Rights Reserved.
+///  \file AklCustomRBTreeAlgorithm.h
+///  Declaration of the AklCustomRBTreeAlgorithm class
+///  \author Ruell Magpayo
+#pragma once
+
+#include "AklCustomRBTreeCommon.h"
+
+/// Augmentation policy of trees whose nodes carry no subtree data
+struct AklCustomRBTreeNoAugment
+{
+    /// True if the nodes carry subtree data that Augment must maintain
+    static const bool IsAugmented = false;
+
+    /// Recomputes the subtree data of the node from its children
+    template <typename Node>
+    static void Augment(Node*)
+    {
+    }
+};
+
+/// Red Black Tree rotations and fixups shared by the trees.
+/// Works on any node type with color, parent, left and right members,
+/// root is the root of the tree and is updated when it changes.
+/// \tparam Augmenter Policy with IsAugmented and a static Augment(Node*), called after
+/// every change to the shape of a subtree
+template <typename Node, typename Augmenter = AklCustomRBTreeNoAugment>
+class AklCustomRBTreeAlgorithm
+{
+public:
+    /// Recomputes the subtree data from the node up to the root.
+    /// \param x The lowest node whose subtree changed, may be null.
+    static void AugmentPath(Node* x)
+    {
+        if (!Augmenter::IsAugmented)
+            return;
+
+        while (x != nullptr)
+        {
+            Augmenter::Augment(x);
+            x = x->parent;
+        }
+    }
+
+    /// Performs a left rotation around the given node.
+    /// This operation maintains the binary search tree property.
+    /// \param x The node around which the left rotation is performed.
+    static void LeftRotate(Node*& root, Node* x) 
+    {
+        Node* y = x->right;
+        x->right = y->left;
+
+        if (y->left != nullptr)
+            y->left->parent = x;
+
+        y->parent = x->parent;
+
+        if (x->parent == nullptr)
+            root = y;
+        else if (x == x->parent->left)
+            x->parent->left = y;
+        else
+            x->parent->right = y;
+
+        y->left = x;
+        x->parent = y;
+
+        if (Augmenter::IsAugmented)
+        {
+            Augmenter::Augment(x);
+            Augmenter::Augment(y);
+        }
+    }
+
+    /// Performs a right rotation around the given node.
+    /// This operation maintains the binary search tree property.
+    /// \param y The node around which the right rotation is performed.
+    static void RightRotate(Node*& root, Node* y) 
+    {
+        Node* x = y->left;
+        y->left = x->right;
+
+        if (x->right != nullptr)
+            x->right->parent = y;
+
+        x->parent = y->parent;
+
+        if (y->parent == nullptr)
+            root = x;
+        else if (y == y->parent->left)
+            y->parent->left = x;
+        else
+            y->parent->right = x;
+
+        x->right = y;
+        y->parent = x;
+
+        if (Augmenter::IsAugmented)
+        {
+            Augmenter::Augment(y);
+            Augmenter::Augment(x);
+        }
+    }
+
+    /// Restores the Red-Black Tree properties after an insertion.
+    /// Fixes any violations caused by the insertion.
+    /// \param z The node that was inserted and may have caused violations.
+    static void InsertFixup(Node*& root, Node* z) 
+    {
+        AugmentPath(z);
+
+        while (z->parent != nullptr && z->parent->color == RED) 
+        {
+            if (z->parent == z->parent->parent->left) {
+                Node* y = z->parent->parent->right;
+                if (y != nullptr && y->color == RED) 
+                {
+                    z->parent->color = BLACK;
+                    y->color = BLACK;
+                    z->parent->parent->color = RED;
+                    z = z->parent->parent;
+                }
+                else 
+                {
+                    if (z == z->parent->right) 
+                    {
+                        z = z->parent;
+                        LeftRotate(root, z);
+                    }
+                    z->parent->color = BLACK;
+                    z->parent->parent->color = RED;
+                    RightRotate(root, z->parent->parent);
+                }
+            }
+            else 
+            {
+                Node* y = z->parent->parent->left;
+                if (y != nullptr && y->color == RED) 
+                {
+                    z->parent->color = BLACK;
+                    y->color = BLACK;
+                    z->parent->parent->color = RED;
+                    z = z->parent->parent;
+                }
+                else 
+                {
+                    if (z == z->parent->left) 
+                    {
+                        z = z->parent;
+                        RightRotate(root, z);
+                    }
+                    z->parent->color = BLACK;
+                    z->parent->parent->color = RED;
+                    LeftRotate(root, z->parent->parent);
+                }
+            }
+        }
+        root->color = BLACK;
+    }
+
+    /// \brief Replaces one subtree as a child of its parent with another subtree.
+    /// Used in transplanting subtrees during the deletion operation.
+    /// \param u The node whose subtree is to be replaced.
+    /// \param v The node whose subtree replaces the subtree rooted at u.
+    static void Transplant(Node*& root, Node* u, Node* v) 
+    {
+        if (u->parent == nullptr)
+            root = v;
+        else if (u == u->parent->left)
+            u->parent->left = v;
+        else
+            u->parent->right = v;
+
+        if (v != nullptr)
+            v->parent = u->parent;
+    }
+
+    /// \brief Finds the node with the minimum key in the subtree rooted at the given node.
+    /// Used in the deletion operation to find the successor of a node.
+    /// \param x The root of the subtree for which the minimum key is to be found.
+    /// \return The node with the minimum key in the subtree rooted at x.
+    static Node* Minimum(Node* x)
+    {
+        while (x->left != nullptr)
+            x = x->left;
+        return x;
+    }
+
+
+    /// \brief Restores the Red-Black Tree properties after a deletion.
+    /// Fixes any violations caused by the deletion.
+    /// \param x The node that replaces the deleted node in the tree, may be null.
+    /// \param xParent The parent of x, tracked separately since x may be null.
+    static void EraseFixup(Node*& root, Node* x, Node* xParent) 
+    {
+        while (x != root && (x == nullptr || x->color == BLACK)) 
+        {
+            if (x == xParent->left) {
+                Node* w = xParent->right;
+                if (w->color == RED) 
+                {
+                    w->color = BLACK;
+                    xParent->color = RED;
+                    LeftRotate(root, xParent);
+                    w = xParent->right;
+                }
+                if ((w->left == nullptr || w->left->color == BLACK) &&
+                    (w->right == nullptr || w->right->color == BLACK)) 
+                {
+                    w->color = RED;
+                    x = xParent;
+                    xParent = x->parent;
+                }
+                else 
+                {
+                    if (w->right == nullptr || w->right->color == BLACK) 
+                    {
+                        if (w->left != nullptr)
+                            w->left->color = BLACK;
+                        w->color = RED;
+                        RightRotate(root, w);
+                        w = xParent->right;
+                    }
+                    w->color = xParent->color;
+                    xParent->color = BLACK;
+                    if (w->right != nullptr)
+                        w->right->color = BLACK;
+                    LeftRotate(root, xParent);
+                    x = root;
+                }
+            }
+            else {
+                Node* w = xParent->left;
+                if (w->color == RED) 
+                {
+                    w->color = BLACK;
+                    xParent->color = RED;
+                    RightRotate(root, xParent);
+                    w = xParent->left;
+                }
+                if ((w->right == nullptr || w->right->color == BLACK) &&
+                    (w->left == nullptr || w->left->color == BLACK)) 
+                {
+                    w->color = RED;
+                    x = xParent;
+                    xParent = x->parent;
+                }
+                else 
+                {
+                    if (w->left == nullptr || w->left->color == BLACK) 
+                    {
+                        if (w->right != nullptr)
+                            w->right->color = BLACK;
+                        w->color = RED;
+                        LeftRotate(root, w);
+                        w = xParent->left;
+                    }
+                    w->color = xParent->color;
+                    xParent->color = BLACK;
+                    if (w->left != nullptr)
+                        w->left->color = BLACK;
+                    RightRotate(root, xParent);
+                    x = root;
+                }
+            }
+        }
+        if (x != nullptr)
+            x->color = BLACK;
+    }
+
+    /// \return the in-order successor of the node, or null
+    static Node* Successor(Node* x)
+    {
+        if (x->right != nullptr)
+        {
+            x = x->right;
+            while (x->left != nullptr)
+                x = x->left;
+            return x;
+        }
+        while (x->parent != nullptr && x == x->parent->right)
+            x = x->parent;
+        return x->parent;
+    }
+
+    /// \return the in-order predecessor of the node, or null
+    static Node* Predecessor(Node* x)
+    {
+        if (x->left != nullptr)
+        {
+            x = x->left;
+            while (x->right != nullptr)
+                x = x->right;
+            return x;
+        }
+        while (x->parent != nullptr && x == x->parent->left)
+            x = x->parent;
+        return x->parent;
+    }
+
+    /// \brief Unlinks the node from the tree and restores the Red-Black Tree properties.
+    /// The successor is relinked in place of the node, so pointers to other nodes stay valid.
+    /// The node itself is not released.
+    /// \param z The node to unlink
+    static void Unlink(Node*& root, Node* z)
+    {
+        Node* y = z;
+        Node* x;
+        Node* xParent;
+        AklCustomRBTreeColor yOriginalColor = y->color;
+
+        if (z->left == nullptr) 
+        {
+            x = z->right;
+            xParent = z->parent;
+            Transplant(root, z, z->right);
+        }
+        else if (z->right == nullptr) 
+        {
+            x = z->left;
+            xParent = z->parent;
+            Transplant(root, z, z->left);
+        }
+        else 
+        {
+            y = Minimum(z->right);
+            yOriginalColor = y->color;
+            x = y->right;
+            if (y->parent == z)
+                xParent = y;
+            else 
+            {
+                xParent = y->parent;
+                Transplant(root, y, y->right);
+                y->right = z->right;
+                y->right->parent = y;
+            }
+            Transplant(root, z, y);
+            y->left = z->left;
+            y->left->parent = y;
+            y->color = z->color;
+        }
+
+        AugmentPath(xParent);
+
+        if (yOriginalColor == BLACK)
+            EraseFixup(root, x, xParent);
+    }
+};
@@ -4,6 +4,18 @@
 ///  \author Ruell Magpayo
 #pragma once
 
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#define AKL_RBTREE_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define AKL_RBTREE_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define AKL_RBTREE_PREFETCH(address) ((void)(address))
+#endif
+
+/// Number of independent searches advanced in lockstep by FindBatch
+#define AKL_RBTREE_BATCH_GROUP_SIZE 16
+
 enum AklCustomRBTreeColor { RED, BLACK };
 
 /// Definition for the custom Red Black Tree Node
@@ -23,6 +35,64 @@ struct AklCustomRBTreeNode
     {}
 };
 
+/// Definition for the custom Red Black Tree Node
+/// Single information, count is the multiplicity of the value
+template <typename Value>
+struct AklCustomRBTreeCountedNode
+{
+    Value value;
+    int count;
+    AklCustomRBTreeColor color;
+    AklCustomRBTreeCountedNode* parent;
+    AklCustomRBTreeCountedNode* left;
+    AklCustomRBTreeCountedNode* right;
+
+    AklCustomRBTreeCountedNode() : count(1), color(BLACK), parent(nullptr), left(nullptr), right(nullptr) {}
+    AklCustomRBTreeCountedNode(Value v, AklCustomRBTreeColor c, AklCustomRBTreeCountedNode* p, AklCustomRBTreeCountedNode* l, AklCustomRBTreeCountedNode* r)
+        : value(v), count(1), color(c), parent(p), left(l), right(r)
+    {}
+};
+
+/// Mode of AklCustomRBTree storing one node per inserted value
+template <typename Value>
+struct AklCustomRBTreeMultiMode
+{
+    typedef AklCustomRBTreeNode<Value> Node;
+
+    /// True if equal values share one node holding their multiplicity
+    static const bool IsCounted = false;
+
+    static int GetCount(const Node*)
+    {
+        return 1;
+    }
+
+    static void SetCount(Node*, int)
+    {
+    }
+};
+
+/// Mode of AklCustomRBTree storing one node per distinct value,
+/// the node's count holds the multiplicity of the value
+template <typename Value>
+struct AklCustomRBTreeCountedMode
+{
+    typedef AklCustomRBTreeCountedNode<Value> Node;
+
+    /// True if equal values share one node holding their multiplicity
+    static const bool IsCounted = true;
+
+    static int GetCount(const Node* node)
+    {
+        return node->count;
+    }
+
+    static void SetCount(Node* node, int count)
+    {
+        node->count = count;
+    }
+};
+
 /// Definition for the custom Red Black Tree Node
 /// Definition with key and value
 template <typename Key, typename Value>
@@ -38,3 +108,42 @@ struct AklCustomRBTreeMapNode {
     AklCustomRBTreeMapNode(Key k, Value v, AklCustomRBTreeColor c, AklCustomRBTreeMapNode* p, AklCustomRBTreeMapNode* l, AklCustomRBTreeMapNode* r)
         : key(k), value(v), color(c), parent(p), left(l), right(r) {}
 };
+
+/// Interval stored in AklCustomRBTreeIntervalMap, keyed by its start
+template <typename Key, typename Value>
+struct AklCustomRBTreeInterval {
+    Key end;
+    Value value;
+
+    AklCustomRBTreeInterval() : end(), value() {}
+    AklCustomRBTreeInterval(const Key& e, const Value& v) : end(e), value(v) {}
+};
+
+/// Definition for the custom Red Black Tree Node
+/// Interval node, maxEnd is the largest end point in the subtree of the node
+template <typename Key, typename Value>
+struct AklCustomRBTreeIntervalNode {
+    Key key;
+    AklCustomRBTreeInterval<Key, Value> value;
+    Key maxEnd;
+    AklCustomRBTreeColor color;
+    AklCustomRBTreeIntervalNode* parent;
+    AklCustomRBTreeIntervalNode* left;
+    AklCustomRBTreeIntervalNode* right;
+
+    AklCustomRBTreeIntervalNode() : color(BLACK), parent(nullptr), left(nullptr), right(nullptr) {}
+};
+
+/// Definition for the custom Red Black Tree Node
+/// Hot part of a key and value node, the value is kept in a separate arena
+template <typename Key, typename Value>
+struct AklCustomRBTreeSplitMapNode {
+    Key key;
+    AklCustomRBTreeColor color;
+    AklCustomRBTreeSplitMapNode* parent;
+    AklCustomRBTreeSplitMapNode* left;
+    AklCustomRBTreeSplitMapNode* right;
+    Value* value;
+
+    AklCustomRBTreeSplitMapNode() : color(BLACK), parent(nullptr), left(nullptr), right(nullptr), value(nullptr) {}
+};
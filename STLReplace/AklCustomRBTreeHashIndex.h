@@ -0,0 +1,177 @@
+/// Copyright  2019-2024 Lincoln Global Inc. All Rights Reserved.
+///  \file AklCustomRBTreeHashIndex.h
+///  Declaration of the AklCustomRBTreeHashIndex class
+///  \author Ruell Magpayo
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/// Index policy of maps without an index, every operation does nothing
+template <typename Key, typename Node>
+class AklCustomRBTreeNoIndex
+{
+public:
+    /// True if the index answers lookups
+    static const bool IsEnabled = false;
+
+    void Reserve(int) {}
+    Node* Find(const Key&) const { return nullptr; }
+    bool Insert(Node*) { return false; }
+    bool Erase(Node*) { return false; }
+    void Clear() {}
+    void Swap(AklCustomRBTreeNoIndex&) {}
+};
+
+/// Open addressing index from key to tree node, kept beside a tree so exact key
+/// lookups cost one probe. Uses linear probing with backward shift deletion and
+/// holds one node per key. Keys are hashed with std::hash.
+template <typename Key, typename Node>
+class AklCustomRBTreeHashIndex
+{
+public:
+    /// True if the index answers lookups
+    static const bool IsEnabled = true;
+
+    AklCustomRBTreeHashIndex() : m_count(0), m_shift(64)
+    {}
+
+    /// Makes room for count nodes without rehashing, keeping the load at most one half
+    /// \param count The expected number of nodes
+    void Reserve(int count)
+    {
+        size_t capacity = 16;
+        while (capacity < static_cast<size_t>(count) * 2)
+            capacity *= 2;
+
+        if (capacity > m_slots.size())
+            Rehash(capacity);
+    }
+
+    /// \return the node with the key or null
+    Node* Find(const Key& key) const
+    {
+        if (m_count == 0)
+            return nullptr;
+
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = Home(key); m_slots[i] != nullptr; i = (i + 1) & mask)
+        {
+            if (m_slots[i]->key == key)
+                return m_slots[i];
+        }
+        return nullptr;
+    }
+
+    /// Indexes the node if its key is not indexed yet
+    /// \param node The node to index
+    /// \return false if another node already holds the key
+    bool Insert(Node* node)
+    {
+        if (static_cast<size_t>(m_count + 1) * 2 > m_slots.size())
+            Reserve(m_count + 1);
+
+        size_t mask = m_slots.size() - 1;
+        size_t i = Home(node->key);
+        for (; m_slots[i] != nullptr; i = (i + 1) & mask)
+        {
+            if (m_slots[i]->key == node->key)
+                return false;
+        }
+
+        m_slots[i] = node;
+        ++m_count;
+        return true;
+    }
+
+    /// Removes the node from the index, nothing happens if another node holds its key
+    /// \param node The node to remove
+    /// \return true if the node was indexed
+    bool Erase(Node* node)
+    {
+        if (m_count == 0)
+            return false;
+
+        size_t mask = m_slots.size() - 1;
+        size_t i = Home(node->key);
+        for (; m_slots[i] != node; i = (i + 1) & mask)
+        {
+            if (m_slots[i] == nullptr)
+                return false;
+        }
+
+        // shift back the following entries that probed past the freed slot
+        for (size_t j = (i + 1) & mask; m_slots[j] != nullptr; j = (j + 1) & mask)
+        {
+            size_t home = Home(m_slots[j]->key);
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+                m_slots[i] = m_slots[j];
+                i = j;
+            }
+        }
+
+        m_slots[i] = nullptr;
+        --m_count;
+        return true;
+    }
+
+    /// Removes all the nodes, keeping the capacity
+    void Clear()
+    {
+        if (m_count > 0)
+            std::fill(m_slots.begin(), m_slots.end(), static_cast<Node*>(nullptr));
+        m_count = 0;
+    }
+
+    /// Removes all the nodes and frees the slots
+    void Release()
+    {
+        m_slots.clear();
+        m_slots.shrink_to_fit();
+        m_count = 0;
+        m_shift = 64;
+    }
+
+    /// Exchanges the contents of two indexes in O(1)
+    void Swap(AklCustomRBTreeHashIndex& other)
+    {
+        m_slots.swap(other.m_slots);
+        std::swap(m_count, other.m_count);
+        std::swap(m_shift, other.m_shift);
+    }
+
+private:
+    std::vector<Node*> m_slots;
+    int m_count;
+    int m_shift;
+
+    /// \return the first slot probed for the key, from the high bits of a Fibonacci hash
+    size_t Home(const Key& key) const
+    {
+        uint64_t hash = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(hash >> m_shift);
+    }
+
+    /// Moves the nodes into a table of the given power of two capacity
+    void Rehash(size_t capacity)
+    {
+        std::vector<Node*> old;
+        old.swap(m_slots);
+        m_slots.assign(capacity, nullptr);
+
+        m_shift = 64;
+        for (size_t c = capacity; c > 1; c /= 2)
+            --m_shift;
+
+        m_count = 0;
+        for (size_t i = 0; i < old.size(); i++)
+        {
+            if (old[i] != nullptr)
+                Insert(old[i]);
+        }
+    }
+};
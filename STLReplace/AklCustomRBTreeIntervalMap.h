@@ -0,0 +1,90 @@
+/// Copyright  2019-2024 Lincoln Global Inc. All Rights Reserved.
+///  \file AklCustomRBTreeIntervalMap.h
+///  Declaration of the AklCustomRBTreeIntervalMap class
+///  \author Ruell Magpayo
+#pragma once
+
+#include "AklCustomRBTreeMap.h"
+
+/// Map of closed intervals [start, end] keyed by start, whose nodes carry the
+/// maximum end point of their subtree so overlap queries skip whole subtrees.
+/// The map is inherited privately so the end of an interval can only change
+/// through Insert and Erase, which keep the subtree maximums up to date.
+template <typename Key, typename Value>
+class AklCustomRBTreeIntervalMap : private AklCustomRBTreeMap<Key, AklCustomRBTreeInterval<Key, Value>, AklCustomRBTreeIntervalLayout<Key, Value>> {
+public:
+    typedef AklCustomRBTreeMap<Key, AklCustomRBTreeInterval<Key, Value>, AklCustomRBTreeIntervalLayout<Key, Value>> Base;
+    typedef typename Base::Node Node;
+
+    using Base::SetNodeCreator;
+    using Base::Erase;
+    using Base::Clear;
+    using Base::Size;
+
+    /// Insert the interval, intervals with the same start are kept side by side
+    /// \param start The start of the interval
+    /// \param end The end of the interval, not less than start
+    /// \param value The value to insert
+    void Insert(const Key& start, const Key& end, const Value& value) 
+    {
+        Base::Insert(start, AklCustomRBTreeInterval<Key, Value>(end, value));
+    }
+
+    /// Copies the map in linear time into one block of the target creator
+    /// \param targetCreator The creator of the copy, or null to allocate from the heap
+    /// \return the copy
+    AklCustomRBTreeIntervalMap Clone(AklCustomRBNodeCreator<Node>* targetCreator) const 
+    {
+        AklCustomRBTreeIntervalMap result;
+        static_cast<Base&>(result) = Base::Clone(targetCreator);
+        return result;
+    }
+
+    /// Visits every interval overlapping [low, high] in O(min(n, (k + 1) log n)) for k matches,
+    /// since ancestors of the matches are visited even when they do not overlap
+    /// \param low The start of the query range
+    /// \param high The end of the query range
+    /// \param visitor Called as visitor(start, end, value) for every overlapping interval in start order
+    template <typename Visitor>
+    void FindOverlapping(const Key& low, const Key& high, Visitor visitor) 
+    {
+        FindOverlappingInternal(Base::GetRoot(), low, high, visitor);
+    }
+
+    /// Visits every interval containing the point in O(min(n, (k + 1) log n)) for k matches
+    /// \param point The point to stab
+    /// \param visitor Called as visitor(start, end, value) for every interval containing the point
+    template <typename Visitor>
+    void FindStabbing(const Key& point, Visitor visitor) 
+    {
+        FindOverlappingInternal(Base::GetRoot(), point, point, visitor);
+    }
+
+private:
+    /// Visits the overlapping intervals of the subtree in order.
+    /// A subtree is skipped when its maximum end is before low, and right
+    /// subtrees are skipped once the start passes high.
+    /// The recursion depth is bounded by the height of the tree.
+    template <typename Visitor>
+    void FindOverlappingInternal(Node* node, const Key& low, const Key& high, Visitor& visitor) 
+    {
+        if (node == nullptr || node->maxEnd < low) 
+        {
+            return;
+        }
+
+        FindOverlappingInternal(node->left, low, high, visitor);
+
+        if (high < node->key) 
+        {
+            return;
+        }
+
+        if (!(node->value.end < low)) 
+        {
+            visitor(node->key, node->value.end, node->value.value);
+        }
+
+        FindOverlappingInternal(node->right, low, high, visitor);
+    }
+};
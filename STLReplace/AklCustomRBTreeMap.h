@@ -5,18 +5,114 @@
 #pragma once
 
 #include "AklCustomRBTreeCommon.h"
+#include "AklCustomRBTreeAlgorithm.h"
 #include "AklCustomRBNodeCreator.h"
+#include "AklCustomRBTreeMapLayout.h"
+#include "AklCustomRBTreeHashIndex.h"
 
-template <typename Key, typename Value>
+#include <utility>
+
+/// \tparam Layout The node layout, AklCustomRBTreeMapSplitLayout keeps values out of the nodes
+/// \tparam Index The key index kept beside the tree, AklCustomRBTreeHashIndex makes exact key
+/// lookups one probe while ordered walks still use the tree
+template <typename Key, typename Value, typename Layout = AklCustomRBTreeMapInlineLayout<Key, Value>,
+    typename Index = AklCustomRBTreeNoIndex<Key, typename Layout::Node>>
 class AklCustomRBTreeMap {
 public:
-    AklCustomRBTreeMap() : m_root(nullptr), m_creator(nullptr)
+    typedef typename Layout::Node Node;
+
+    /// Remembers the last node reached by a lookup so the next nearby lookup starts from it.
+    /// Erase, Clear, Swap and moving or assigning the map forget the node,
+    /// and the next lookup starts from the root. A cursor must not outlive its map.
+    class Cursor {
+    public:
+        Cursor(AklCustomRBTreeMap& map) : m_map(&map), m_node(nullptr), m_generation(map.m_generation)
+        {}
+
+        /// Searches for the key starting from the last node reached.
+        /// \param key The key to search for.
+        /// \return A pointer to the node with the specified key if found, otherwise nullptr.
+        Node* Seek(const Key& key) 
+        {
+            return m_map->FindNear(*this, key);
+        }
+
+        /// \return The last node reached, the node found or the last one visited on a miss,
+        /// nullptr once nodes have left the map since.
+        Node* Get() const 
+        {
+            return m_generation == m_map->m_generation ? m_node : nullptr;
+        }
+
+        /// Forgets the last node, the next lookup starts from the root.
+        void Reset() 
+        {
+            m_node = nullptr;
+        }
+
+    private:
+        friend class AklCustomRBTreeMap;
+
+        AklCustomRBTreeMap* m_map;
+        Node* m_node;
+        unsigned int m_generation;
+    };
+
+    AklCustomRBTreeMap() : m_root(nullptr), m_creator(nullptr), m_size(0), m_generation(0)
     {}
 
-    /// Sets the node creator
-    void SetNodeCreator(AklCustomRBNodeCreator<AklCustomRBTreeMapNode<Key, Value>>* creator)
+    /// Copy constructor, the copy obtains its nodes from the same creators
+    AklCustomRBTreeMap(const AklCustomRBTreeMap& other) : m_root(nullptr), m_creator(other.m_creator), m_size(0), m_layout(other.m_layout), m_generation(0)
+    {
+        if (m_creator) 
+        {
+            m_creator->Reserve(other.m_size);
+        }
+        m_root = CopyNodes(other.m_root, m_creator);
+        m_size = other.m_size;
+        RebuildIndex();
+    }
+
+    /// Move constructor, takes the nodes of the other map in O(1)
+    AklCustomRBTreeMap(AklCustomRBTreeMap&& other) : m_root(other.m_root), m_creator(other.m_creator), m_size(other.m_size), m_layout(other.m_layout), m_generation(0)
     {
+        m_index.Swap(other.m_index);
+        other.m_root = nullptr;
+        other.m_size = 0;
+        ++other.m_generation;
+    }
+
+    ~AklCustomRBTreeMap()
+    {
+        Clear();
+    }
+
+    /// Sets the node creator, the index is sized from the creator's node count
+    /// A map has one owner for all its nodes, so the creator only changes while the map is empty
+    void SetNodeCreator(AklCustomRBNodeCreator<Node>* creator)
+    {
+        if (m_root != nullptr) 
+        {
+            return;
+        }
+
         m_creator = creator;
+        if (m_creator && m_creator->GetCount() > m_size) 
+        {
+            m_index.Reserve(m_creator->GetCount());
+        }
+    }
+
+    /// \return The node layout, used to set the value creator of a split layout
+    Layout& GetLayout()
+    {
+        return m_layout;
+    }
+
+    /// \return The value stored in the node
+    Value& GetValue(Node* node)
+    {
+        return m_layout.GetValue(node);
     }
 
     /// Insert Key value pair
@@ -24,25 +120,194 @@ public:
     /// \param value The value to insert
     void Insert(const Key& key, const Value& value) 
     {
-        AklCustomRBTreeMapNode<Key, Value>* node = nullptr;// = 
+        Node* node = CreateNode(key, value, m_creator);
         
-        if (m_creator)
+        InsertNode(node);
+        ++m_size;
+        Algorithm::InsertFixup(m_root, node);
+
+        m_index.Insert(node);
+    }
+
+    /// Erase the key and its value, one of them when the key was inserted several times
+    /// \param key The key to erase
+    void Erase(const Key& key) 
+    {
+        Node* node = Find(key);
+        if (node != nullptr) 
         {
-            node = m_creator->Obtain();
-            node->key = key;
-            node->value = value;
-            node->color = RED;
-            node->parent = nullptr;
-            node->left = nullptr;
-            node->right = nullptr;
+            EraseNode(node);
         }
-        else
+    }
+
+    /// Searches for a node with the given key, through the index when there is one.
+    /// \param key The key to search for.
+    /// \return A pointer to the node with the specified key if found, otherwise nullptr.
+    Node* Find(const Key& key) 
+    {
+        if (Index::IsEnabled) 
         {
-            node = new AklCustomRBTreeMapNode<Key, Value>(key, value, RED, nullptr, nullptr, nullptr);
+            return m_index.Find(key);
+        }
+
+        return FindInTree(key);
+    }
+
+    /// Searches for a node with the given key in the Red-Black Tree.
+    /// \param key The key to search for.
+    /// \return A pointer to the node with the specified key if found, otherwise nullptr.
+    Node* FindInTree(const Key& key) 
+    {
+        Node* current = m_root;
+
+        while (current != nullptr) 
+        {
+            if (key == current->key) 
+            {
+                return current;
+            }
+            else if (key < current->key) 
+            {
+                current = current->left;
+            }
+            else 
+            {
+                current = current->right;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// Finger search, searches for the key starting from the cursor's last node.
+    /// Climbs through the parents only until the subtree must hold the key, then descends,
+    /// so a key d positions away from the previous one costs O(log d).
+    /// \param cursor The cursor of this map, moved to the node reached. The search starts from
+    /// the root when the node may have left the map, a cursor of another map is rebound to this one.
+    /// \param key The key to search for.
+    /// \return A pointer to the node with the specified key if found, otherwise nullptr.
+    Node* FindNear(Cursor& cursor, const Key& key) 
+    {
+        if (cursor.m_map != this || cursor.m_generation != m_generation) 
+        {
+            cursor.m_map = this;
+            cursor.m_node = nullptr;
+            cursor.m_generation = m_generation;
+        }
+
+        Node* current = cursor.m_node != nullptr ? cursor.m_node : m_root;
+        if (current == nullptr) 
+        {
+            return nullptr;
+        }
+
+        if (cursor.m_node != nullptr && !(key == current->key)) 
+        {
+            if (current->key < key) 
+            {
+                // a left child whose parent is above the key bounds the key from both sides
+                while (current->parent != nullptr && !(current == current->parent->left && key < current->parent->key)) 
+                {
+                    current = current->parent;
+                    if (key == current->key) 
+                    {
+                        break;
+                    }
+                }
+            }
+            else 
+            {
+                while (current->parent != nullptr && !(current == current->parent->right && current->parent->key < key)) 
+                {
+                    current = current->parent;
+                    if (key == current->key) 
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        while (true) 
+        {
+            if (key == current->key) 
+            {
+                cursor.m_node = current;
+                return current;
+            }
+
+            Node* next = key < current->key ? current->left : current->right;
+            if (next == nullptr) 
+            {
+                cursor.m_node = current;
+                return nullptr;
+            }
+            current = next;
+        }
+    }
+
+    /// Searches for a batch of keys, advancing a group of independent searches in lockstep
+    /// and prefetching the next node of each search so that their cache misses overlap.
+    /// \param keys The keys to search for.
+    /// \param count The number of keys.
+    /// \param result Receives the node with the specified key, or nullptr, for every key.
+    void FindBatch(const Key* keys, int count, Node** result)
+    {
+        if (Index::IsEnabled) 
+        {
+            for (int i = 0; i < count; i++) 
+            {
+                result[i] = m_index.Find(keys[i]);
+            }
+            return;
+        }
+
+        Node* current[AKL_RBTREE_BATCH_GROUP_SIZE];
+
+        for (int base = 0; base < count; base += AKL_RBTREE_BATCH_GROUP_SIZE)
+        {
+            int groupSize = count - base;
+            if (groupSize > AKL_RBTREE_BATCH_GROUP_SIZE) 
+            {
+                groupSize = AKL_RBTREE_BATCH_GROUP_SIZE;
+            }
+
+            for (int i = 0; i < groupSize; i++) 
+            {
+                current[i] = m_root;
+                result[base + i] = nullptr;
+            }
+
+            int active = groupSize;
+            while (active > 0) 
+            {
+                active = 0;
+                for (int i = 0; i < groupSize; i++) 
+                {
+                    Node* node = current[i];
+                    if (node == nullptr) 
+                    {
+                        continue;
+                    }
+
+                    const Key& key = keys[base + i];
+                    if (key == node->key) 
+                    {
+                        result[base + i] = node;
+                        current[i] = nullptr;
+                        continue;
+                    }
+
+                    node = key < node->key ? node->left : node->right;
+                    if (node != nullptr) 
+                    {
+                        AKL_RBTREE_PREFETCH(node);
+                        ++active;
+                    }
+                    current[i] = node;
+                }
+            }
         }
-        
-        InsertNode(node);
-        FixInsert(node);
     }
 
     /// Clears the tree
@@ -50,22 +315,56 @@ public:
     void Clear()
     {
         // if the nodes are created from a creator, we dont need to do the cleanup
-        if(m_creator == nullptr)
+        // unless the layout owns values outside the nodes
+        if(m_creator == nullptr || Layout::OwnsValues)
             ClearInternal(m_root);
 
         m_root = nullptr;
+        m_size = 0;
+        m_index.Clear();
+        ++m_generation;
+    }
+
+    /// \return the number of elements in the map
+    int Size() const
+    {
+        return m_size;
+    }
+
+    /// Insert the key value pair only if the key is not yet in the map, with a single descent.
+    /// Nothing is allocated when the key already exists.
+    /// \param key The Key to insert
+    /// \param value The value to insert
+    /// \return The node holding the key and true if it was inserted
+    std::pair<Node*, bool> InsertUnique(const Key& key, const Value& value) 
+    {
+        Node* parent = nullptr;
+        bool goLeft = false;
+        Node* node = FindInsertPosition(key, parent, goLeft);
+
+        if (node != nullptr) 
+        {
+            return std::make_pair(node, false);
+        }
+
+        node = CreateNode(key, value, m_creator);
+        LinkNode(node, parent, goLeft);
+        return std::make_pair(node, true);
     }
 
     /// Access value thru its key
     Value& operator[](const Key& key) 
     {
-        AklCustomRBTreeMapNode<Key, Value>* node = Find(key);
-        if (node == nullptr) {
-            Value default_value = Value();
-            Insert(key, default_value);
-            node = Find(key);
+        Node* parent = nullptr;
+        bool goLeft = false;
+        Node* node = FindInsertPosition(key, parent, goLeft);
+
+        if (node == nullptr) 
+        {
+            node = CreateNode(key, Value(), m_creator);
+            LinkNode(node, parent, goLeft);
         }
-        return node->value;
+        return m_layout.GetValue(node);
     }
 
     /// Assignment Operator
@@ -74,11 +373,66 @@ public:
         if (this != &other) 
         {
             Clear();
-            CopyTree(m_root, other.m_root);
+            if (m_creator) 
+            {
+                m_creator->Reserve(other.m_size);
+            }
+            m_root = CopyNodes(other.m_root, m_creator);
+            m_size = other.m_size;
+            RebuildIndex();
         }
         return *this;
     }
 
+    /// Move Assignment Operator, takes the nodes of the other map in O(1)
+    AklCustomRBTreeMap& operator=(AklCustomRBTreeMap&& other) 
+    {
+        if (this != &other) 
+        {
+            Clear();
+            m_root = other.m_root;
+            m_creator = other.m_creator;
+            m_size = other.m_size;
+            m_layout = other.m_layout;
+            m_index.Swap(other.m_index);
+            other.m_root = nullptr;
+            other.m_size = 0;
+            ++other.m_generation;
+        }
+        return *this;
+    }
+
+    /// Exchanges the contents of two maps in O(1)
+    void Swap(AklCustomRBTreeMap& other)
+    {
+        std::swap(m_root, other.m_root);
+        std::swap(m_creator, other.m_creator);
+        std::swap(m_size, other.m_size);
+        std::swap(m_layout, other.m_layout);
+        m_index.Swap(other.m_index);
+        ++m_generation;
+        ++other.m_generation;
+    }
+
+    /// Copies the map in linear time into one block of the target creator
+    /// The values of a split layout are copied with the same value creator
+    /// \param targetCreator The creator of the copy, or null to allocate from the heap
+    /// \return the copy
+    AklCustomRBTreeMap Clone(AklCustomRBNodeCreator<Node>* targetCreator) const
+    {
+        AklCustomRBTreeMap result;
+        result.m_creator = targetCreator;
+        result.m_layout = m_layout;
+        if (targetCreator) 
+        {
+            targetCreator->Reserve(m_size);
+        }
+        result.m_root = result.CopyNodes(m_root, targetCreator);
+        result.m_size = m_size;
+        result.RebuildIndex();
+        return result;
+    }
+
 #if _DEBUG
     void Print() 
     {
@@ -86,78 +440,103 @@ public:
     }
 #endif
 
-private:
-    AklCustomRBTreeMapNode<Key, Value>* m_root;
-    AklCustomRBNodeCreator<AklCustomRBTreeMapNode<Key, Value>>* m_creator;
-
-    /// Performs a left rotation on the Red-Black Tree rooted at the given node.
-    /// \param node The node around which the left rotation is performed.
-    void LeftRotate(AklCustomRBTreeMapNode<Key, Value>* node) 
+protected:
+    /// \return The root node, for variants that walk the tree themselves
+    Node* GetRoot() const
     {
-        AklCustomRBTreeMapNode<Key, Value>* rightChild = node->right;
-        node->right = rightChild->left;
+        return m_root;
+    }
 
-        if (rightChild->left != nullptr) 
+private:
+    typedef AklCustomRBTreeAlgorithm<Node, Layout> Algorithm;
+
+    Node* m_root;
+    AklCustomRBNodeCreator<Node>* m_creator;
+    int m_size;
+    Layout m_layout;
+    Index m_index;
+    // advanced whenever nodes leave the map, so cursors taken before know their node may be gone
+    unsigned int m_generation;
+
+    /// Refills the index from the tree.
+    void RebuildIndex() 
+    {
+        m_index.Clear();
+        if (!Index::IsEnabled) 
         {
-            rightChild->left->parent = node;
+            return;
         }
 
-        rightChild->parent = node->parent;
-
-        if (node->parent == nullptr) 
+        int expected = m_size;
+        if (m_creator && m_creator->GetCount() > expected) 
         {
-            m_root = rightChild;
+            expected = m_creator->GetCount();
         }
-        else if (node == node->parent->left) 
-        {
-            node->parent->left = rightChild;
-        }
-        else 
+        m_index.Reserve(expected);
+
+        for (Node* node = m_root != nullptr ? Algorithm::Minimum(m_root) : nullptr; node != nullptr; node = Algorithm::Successor(node)) 
         {
-            node->parent->right = rightChild;
+            m_index.Insert(node);
         }
-
-        rightChild->left = node;
-        node->parent = rightChild;
     }
 
-    /// Performs a right rotation on the Red-Black Tree rooted at the given node.
-    /// \param node The node around which the right rotation is performed.
-    void RightRotate(AklCustomRBTreeMapNode<Key, Value>* node) 
+    /// Unlinks the node from the tree, rebalances and releases it.
+    /// The successor is relinked in place of the node, so pointers to other nodes stay valid.
+    /// \param node The node to erase.
+    void EraseNode(Node* node) 
     {
-        AklCustomRBTreeMapNode<Key, Value>* leftChild = node->left;
-        node->left = leftChild->right;
-
-        if (leftChild->right != nullptr) 
-        {
-            leftChild->right->parent = node;
-        }
+        bool indexed = m_index.Erase(node);
 
-        leftChild->parent = node->parent;
+        Algorithm::Unlink(m_root, node);
+        --m_size;
 
-        if (node->parent == nullptr) 
+        // another node inserted with the same key takes over the index entry
+        if (indexed) 
         {
-            m_root = leftChild;
+            Node* sameKey = FindInTree(node->key);
+            if (sameKey != nullptr) 
+            {
+                m_index.Insert(sameKey);
+            }
         }
-        else if (node == node->parent->left) 
+
+        m_layout.ReleaseValue(node);
+        if (m_creator) 
         {
-            node->parent->left = leftChild;
+            m_creator->Recycle(node);
         }
         else 
         {
-            node->parent->right = leftChild;
+            delete node;
         }
+        ++m_generation;
+    }
+
+    /// Creates a detached red node holding the key value pair.
+    /// \param key The key of the node.
+    /// \param value The value of the node.
+    /// \param creator The creator to obtain the node from, or nullptr to allocate from the heap.
+    /// \return The new node.
+    Node* CreateNode(const Key& key, const Value& value, AklCustomRBNodeCreator<Node>* creator)
+    {
+        Node* node = creator ? creator->Obtain() : new Node();
+
+        node->key = key;
+        node->color = RED;
+        node->parent = nullptr;
+        node->left = nullptr;
+        node->right = nullptr;
+        m_layout.SetValue(node, value);
 
-        leftChild->right = node;
-        node->parent = leftChild;
+        return node;
     }
 
     /// Inserts a new node with the specified key and value into the Red-Black Tree.
     /// \param newNode The new node to be inserted.
-    void InsertNode(AklCustomRBTreeMapNode<Key, Value>* newNode) 
+    void InsertNode(Node* newNode) 
     {
-        AklCustomRBTreeMapNode<Key, Value>* parent = nullptr;
-        AklCustomRBTreeMapNode<Key, Value>* current = m_root;
+        Node* parent = nullptr;
+        Node* current = m_root;
 
         while (current != nullptr) 
         {
@@ -188,133 +567,157 @@ private:
         }
     }
 
-    /// Fixes the Red-Black Tree properties after the insertion of a new node.
-    /// \param node The newly inserted node that may violate the Red-Black Tree properties.
-    void FixInsert(AklCustomRBTreeMapNode<Key, Value>* node) 
+    /// Searches for the key, remembering where a new node would be linked if it is missing.
+    /// \param key The key to search for.
+    /// \param parent Receives the parent of the new node.
+    /// \param goLeft Receives true if the new node would be the left child of parent.
+    /// \return The node with the specified key if found, otherwise nullptr.
+    Node* FindInsertPosition(const Key& key, Node*& parent, bool& goLeft) 
     {
-        while (node != m_root && node->parent->color == RED) 
+        if (Index::IsEnabled) 
         {
-            if (node->parent == node->parent->parent->left) 
+            Node* indexed = m_index.Find(key);
+            if (indexed != nullptr) 
             {
-                AklCustomRBTreeMapNode<Key, Value>* uncle = node->parent->parent->right;
-
-                if (uncle != nullptr && uncle->color == RED) 
-                {
-                    node->parent->color = BLACK;
-                    uncle->color = BLACK;
-                    node->parent->parent->color = RED;
-                    node = node->parent->parent;
-                }
-                else {
-                    if (node == node->parent->right) 
-                    {
-                        node = node->parent;
-                        LeftRotate(node);
-                    }
-
-                    node->parent->color = BLACK;
-                    node->parent->parent->color = RED;
-                    RightRotate(node->parent->parent);
-                }
+                return indexed;
             }
-            else 
-            {
-                AklCustomRBTreeMapNode<Key, Value>* uncle = node->parent->parent->left;
+        }
 
-                if (uncle != nullptr && uncle->color == RED) 
-                {
-                    node->parent->color = BLACK;
-                    uncle->color = BLACK;
-                    node->parent->parent->color = RED;
-                    node = node->parent->parent;
-                }
-                else 
-                {
-                    if (node == node->parent->left) 
-                    {
-                        node = node->parent;
-                        RightRotate(node);
-                    }
+        Node* current = m_root;
 
-                    node->parent->color = BLACK;
-                    node->parent->parent->color = RED;
-                    LeftRotate(node->parent->parent);
-                }
+        while (current != nullptr) 
+        {
+            if (key == current->key) 
+            {
+                return current;
             }
+
+            parent = current;
+            goLeft = key < current->key;
+            current = goLeft ? current->left : current->right;
         }
 
-        m_root->color = BLACK;
+        return nullptr;
     }
 
-    /// Searches for a node with the given key in the Red-Black Tree.
-    /// \param key The key to search for.
-    /// \return A pointer to the node with the specified key if found, otherwise nullptr.
-    AklCustomRBTreeMapNode<Key, Value>* Find(const Key& key) 
+    /// Links a new node below the position found by FindInsertPosition and rebalances.
+    /// \param newNode The new node to be linked.
+    /// \param parent The parent of the new node, nullptr for an empty tree.
+    /// \param goLeft True if the new node is the left child of parent.
+    void LinkNode(Node* newNode, Node* parent, bool goLeft) 
     {
-        AklCustomRBTreeMapNode<Key, Value>* current = m_root;
+        newNode->parent = parent;
 
-        while (current != nullptr) 
+        if (parent == nullptr) 
         {
-            if (key == current->key) 
-            {
-                return current;
-            }
-            else if (key < current->key) 
+            m_root = newNode;
+        }
+        else if (goLeft) 
+        {
+            parent->left = newNode;
+        }
+        else 
+        {
+            parent->right = newNode;
+        }
+
+        ++m_size;
+        Algorithm::InsertFixup(m_root, newNode);
+
+        m_index.Insert(newNode);
+    }
+
+    /// Clears the nodes without recursion, releasing their values and deleting heap allocated nodes.
+    /// Left children are rotated up until the node has none, then the node is released.
+    /// \param node The root of the subtree to clear.
+    void ClearInternal(Node* node) 
+    {
+        while (node != nullptr) 
+        {
+            if (node->left != nullptr) 
             {
-                current = current->left;
+                Node* leftChild = node->left;
+                node->left = leftChild->right;
+                leftChild->right = node;
+                node = leftChild;
             }
             else 
             {
-                current = current->right;
+                Node* rightChild = node->right;
+                m_layout.ReleaseValue(node);
+                if (m_creator == nullptr) 
+                {
+                    delete node;
+                }
+                node = rightChild;
             }
         }
-
-        return nullptr;
     }
 
-    /// Clears and delete the node
-    void ClearInternal(AklCustomRBTreeMapNode<Key, Value>* node) {
-        if (node != nullptr) 
+    /// Copy the tree node content without recursion, linking the parents of the copy.
+    /// Nodes are created in pre-order, so a reserved creator hands them out from one block.
+    /// \param source The root of the subtree to copy.
+    /// \param creator The creator to obtain the nodes from, or nullptr to allocate from the heap.
+    /// \return The root of the copy.
+    Node* CopyNodes(const Node* source, AklCustomRBNodeCreator<Node>* creator) 
+    {
+        if (source == nullptr) 
         {
-            ClearInternal(node->left);
-            ClearInternal(node->right);
-            delete node;
+            return nullptr;
         }
-    }
 
-    /// Copy the tree node content
-    void CopyTree(AklCustomRBTreeMapNode<Key, Value>*& destination, const AklCustomRBTreeMapNode<Key, Value>* source) 
-    {
-        if (source != nullptr) 
+        Node* root = CreateNode(source->key, m_layout.GetValue(source), creator);
+        root->color = source->color;
+
+        const Node* sourceRoot = source;
+        Node* destination = root;
+
+        while (true) 
         {
-            if (m_creator)
+            if (source->left != nullptr && destination->left == nullptr) 
             {
-                destination = m_creator->Obtain();
-                destination->key = source->key;
-                destination->value = source->value;
+                source = source->left;
+                destination->left = CreateNode(source->key, m_layout.GetValue(source), creator);
+                destination->left->parent = destination;
+                destination = destination->left;
                 destination->color = source->color;
-                destination->parent = nullptr;
-                destination->left = nullptr;
-                destination->right = nullptr;
             }
-            else
+            else if (source->right != nullptr && destination->right == nullptr) 
             {
-               // node = new AklCustomRBTreeMapNode<Key, Value>(key, value, RED, nullptr, nullptr, nullptr);
-                destination = new AklCustomRBTreeMapNode<Key, Value>(source->key, source->value, source->color, nullptr, nullptr, nullptr);
+                source = source->right;
+                destination->right = CreateNode(source->key, m_layout.GetValue(source), creator);
+                destination->right->parent = destination;
+                destination = destination->right;
+                destination->color = source->color;
             }
+            else 
+            {
+                // both subtrees are copied, so the subtree data can be computed
+                if (Layout::IsAugmented) 
+                {
+                    Layout::Augment(destination);
+                }
+
+                if (source == sourceRoot) 
+                {
+                    break;
+                }
 
-            CopyTree(destination->left, source->left);
-            CopyTree(destination->right, source->right);
+                source = source->parent;
+                destination = destination->parent;
+            }
         }
+
+        return root;
     }
 
 #if _DEBUG
-    void PrintContents(AklCustomRBTreeMapNode<Key, Value>* node)
+    void PrintContents(Node* node)
     {
         if (node != nullptr) 
         {
             PrintContents(node->left);
-            std::cout << "(" << node->key << ": " << node->value << ") " << std::endl;
+            std::cout << "(" << node->key << ": " << m_layout.GetValue(node) << ") " << std::endl;
             PrintContents(node->right);
         }
     }
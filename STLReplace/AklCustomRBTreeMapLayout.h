@@ -0,0 +1,163 @@
+/// Copyright  2019-2024 Lincoln Global Inc. All Rights Reserved.
+///  \file AklCustomRBTreeMapLayout.h
+///  Declaration of the node layout policies of AklCustomRBTreeMap
+///  \author Ruell Magpayo
+#pragma once
+
+#include "AklCustomRBTreeCommon.h"
+#include "AklCustomRBNodeCreator.h"
+
+/// Layout storing the value inline in the node, next to the key and links
+template <typename Key, typename Value>
+class AklCustomRBTreeMapInlineLayout
+{
+public:
+    typedef AklCustomRBTreeMapNode<Key, Value> Node;
+
+    /// True if the nodes carry subtree data that Augment must maintain
+    static const bool IsAugmented = false;
+
+    /// True if values live outside the nodes and must be released on Clear
+    static const bool OwnsValues = false;
+
+    Value& GetValue(Node* node) const
+    {
+        return node->value;
+    }
+
+    const Value& GetValue(const Node* node) const
+    {
+        return node->value;
+    }
+
+    /// Stores the value in a node that has no value yet
+    void SetValue(Node* node, const Value& value)
+    {
+        node->value = value;
+    }
+
+    /// Releases the value of a node leaving the map, before the node is released
+    void ReleaseValue(Node*)
+    {
+    }
+
+    /// Recomputes the subtree data of the node from its children
+    static void Augment(Node*)
+    {
+    }
+};
+
+/// Layout keeping the key, color and links in a compact hot node while the value
+/// lives in a separate arena, so a descent never brings value bytes into cache.
+/// Values are obtained from the value creator, or from the heap when none is set.
+template <typename Key, typename Value>
+class AklCustomRBTreeMapSplitLayout
+{
+public:
+    typedef AklCustomRBTreeSplitMapNode<Key, Value> Node;
+
+    /// True if the nodes carry subtree data that Augment must maintain
+    static const bool IsAugmented = false;
+
+    /// True if values live outside the nodes and must be released on Clear
+    static const bool OwnsValues = true;
+
+    AklCustomRBTreeMapSplitLayout() : m_valueCreator(nullptr)
+    {}
+
+    /// Sets the creator of the values
+    /// All the values of a map must come from one owner, so set it while the map is empty
+    void SetValueCreator(AklCustomRBNodeCreator<Value>* creator)
+    {
+        m_valueCreator = creator;
+    }
+
+    Value& GetValue(Node* node) const
+    {
+        return *node->value;
+    }
+
+    const Value& GetValue(const Node* node) const
+    {
+        return *node->value;
+    }
+
+    /// Stores the value in a node that has no value yet
+    void SetValue(Node* node, const Value& value)
+    {
+        if (m_valueCreator)
+        {
+            node->value = m_valueCreator->Obtain();
+            *node->value = value;
+        }
+        else
+        {
+            node->value = new Value(value);
+        }
+    }
+
+    /// Releases the value of a node leaving the map, before the node is released
+    void ReleaseValue(Node* node)
+    {
+        if (m_valueCreator)
+            m_valueCreator->Recycle(node->value);
+        else
+            delete node->value;
+        node->value = nullptr;
+    }
+
+    /// Recomputes the subtree data of the node from its children
+    static void Augment(Node*)
+    {
+    }
+
+private:
+    AklCustomRBNodeCreator<Value>* m_valueCreator;
+};
+
+/// Inline layout whose nodes also carry the maximum end point of their subtree,
+/// used by AklCustomRBTreeIntervalMap to prune overlap queries
+template <typename Key, typename Value>
+class AklCustomRBTreeIntervalLayout
+{
+public:
+    typedef AklCustomRBTreeIntervalNode<Key, Value> Node;
+
+    /// True if the nodes carry subtree data that Augment must maintain
+    static const bool IsAugmented = true;
+
+    /// True if values live outside the nodes and must be released on Clear
+    static const bool OwnsValues = false;
+
+    AklCustomRBTreeInterval<Key, Value>& GetValue(Node* node) const
+    {
+        return node->value;
+    }
+
+    const AklCustomRBTreeInterval<Key, Value>& GetValue(const Node* node) const
+    {
+        return node->value;
+    }
+
+    /// Stores the value in a node that has no value yet
+    void SetValue(Node* node, const AklCustomRBTreeInterval<Key, Value>& value)
+    {
+        node->value = value;
+        node->maxEnd = value.end;
+    }
+
+    /// Releases the value of a node leaving the map, before the node is released
+    void ReleaseValue(Node*)
+    {
+    }
+
+    /// Recomputes the subtree data of the node from its children
+    static void Augment(Node* node)
+    {
+        node->maxEnd = node->value.end;
+        if (node->left != nullptr && node->maxEnd < node->left->maxEnd)
+            node->maxEnd = node->left->maxEnd;
+        if (node->right != nullptr && node->maxEnd < node->right->maxEnd)
+            node->maxEnd = node->right->maxEnd;
+    }
+};